@@ -0,0 +1,169 @@
+#include "OnsetDetector.h"
+
+namespace
+{
+    // Flux has to exceed its recent average by this factor to count as an onset
+    constexpr float adaptiveThresholdRatio = 1.5f;
+    
+    // One-pole smoothing of the flux average, per hop
+    constexpr float meanFluxCoeff = 0.1f;
+}
+
+//==============================================================================
+void OnsetDetector::prepare(double sampleRate)
+{
+    // Keep the frame around 10 ms regardless of sample rate, with 4x overlap
+    int fftOrder = 9;
+    
+    while ((1 << fftOrder) < sampleRate * 0.01 && fftOrder < 12)
+        ++fftOrder;
+    
+    fftSize = 1 << fftOrder;
+    subFftSize = fftSize / numSubTransforms;
+    static_assert(numSubTransforms == 4, "sub-transform order assumes a factor of four");
+    subFft = std::make_unique<juce::dsp::FFT>(fftOrder - 2);
+    hopSize = fftSize / 4;
+    stageInterval = juce::jmax(1, hopSize / numStages);
+    
+    inputFrame.assign((size_t) fftSize, 0.0f);
+    window.assign((size_t) fftSize, 0.0f);
+    windowedFrame.assign((size_t) fftSize, 0.0f);
+    subInput.assign((size_t) subFftSize, {});
+    subSpectra.assign((size_t) fftSize, {});
+    twiddles.resize((size_t) fftSize);
+    previousMagnitudes.assign((size_t) fftSize / 2 + 1, 0.0f);
+    
+    for (int m = 0; m < fftSize; ++m)
+        twiddles[(size_t) m] = std::polar(1.0f, -juce::MathConstants<float>::twoPi * (float) m / (float) fftSize);
+    
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), (size_t) fftSize,
+                                                             juce::dsp::WindowingFunction<float>::hann, false);
+    
+    // Scale so a full-scale sinusoid reads as a magnitude of about 1.0
+    float windowSum = std::accumulate(window.begin(), window.end(), 0.0f);
+    magnitudeScale = windowSum > 0.0f ? 2.0f / windowSum : 1.0f;
+    
+    reset();
+}
+
+void OnsetDetector::reset()
+{
+    std::fill(inputFrame.begin(), inputFrame.end(), 0.0f);
+    std::fill(windowedFrame.begin(), windowedFrame.end(), 0.0f);
+    std::fill(subSpectra.begin(), subSpectra.end(), Complex());
+    std::fill(previousMagnitudes.begin(), previousMagnitudes.end(), 0.0f);
+    
+    inputPosition = 0;
+    hopPosition = 0;
+    nextStage = 0;
+    fluxSquared = 0.0f;
+    meanFlux = 0.0f;
+    onsetSamplesRemaining = 0;
+}
+
+bool OnsetDetector::processSample(float sample, float minimumFlux)
+{
+    if (subFft == nullptr)
+        return false;
+    
+    inputFrame[(size_t) inputPosition] = sample;
+    
+    if (++inputPosition == fftSize)
+        inputPosition = 0;
+    
+    // One stage every stageInterval samples, starting at the hop boundary
+    if (hopPosition == 0)
+        nextStage = 0;
+    
+    if (nextStage < numStages && hopPosition == nextStage * stageInterval)
+        runStage(nextStage++, minimumFlux);
+    
+    if (++hopPosition == hopSize)
+        hopPosition = 0;
+    
+    if (onsetSamplesRemaining > 0)
+    {
+        --onsetSamplesRemaining;
+        return true;
+    }
+    
+    return false;
+}
+
+void OnsetDetector::runStage(int stage, float minimumFlux)
+{
+    if (stage == 0)
+    {
+        captureFrame();
+        return;
+    }
+    
+    if (stage <= numSubTransforms)
+    {
+        computeSubTransform(stage - 1);
+        return;
+    }
+    
+    // Combine stages each cover an equal slice of bins 0..fftSize/2
+    int combineIndex = stage - 1 - numSubTransforms;
+    int numBins = fftSize / 2 + 1;
+    int firstBin = numBins * combineIndex / numCombineStages;
+    int endBin = numBins * (combineIndex + 1) / numCombineStages;
+    
+    combineAndAccumulateFlux(firstBin, endBin);
+    
+    if (combineIndex == numCombineStages - 1)
+        detectOnset(minimumFlux);
+}
+
+void OnsetDetector::captureFrame()
+{
+    // Unroll the circular buffer, oldest sample first, applying the window
+    for (int i = 0; i < fftSize; ++i)
+    {
+        int index = (inputPosition + i) % fftSize;
+        windowedFrame[(size_t) i] = inputFrame[(size_t) index] * window[(size_t) i];
+    }
+    
+    fluxSquared = 0.0f;
+}
+
+void OnsetDetector::computeSubTransform(int index)
+{
+    // Every numSubTransforms-th sample starting at index
+    for (int n = 0; n < subFftSize; ++n)
+        subInput[(size_t) n] = Complex(windowedFrame[(size_t) (n * numSubTransforms + index)], 0.0f);
+    
+    subFft->perform(subInput.data(), subSpectra.data() + index * subFftSize, false);
+}
+
+void OnsetDetector::combineAndAccumulateFlux(int firstBin, int endBin)
+{
+    // X[k] = sum_r W^(r k) X_r[k mod subFftSize], then rectified L2 flux on |X[k]|
+    for (int bin = firstBin; bin < endBin; ++bin)
+    {
+        int subBin = bin % subFftSize;
+        Complex sum = subSpectra[(size_t) subBin];
+        
+        for (int r = 1; r < numSubTransforms; ++r)
+            sum += twiddles[(size_t) ((r * bin) % fftSize)] * subSpectra[(size_t) (r * subFftSize + subBin)];
+        
+        float magnitude = std::abs(sum) * magnitudeScale;
+        float rise = magnitude - previousMagnitudes[(size_t) bin];
+        
+        if (rise > 0.0f)
+            fluxSquared += rise * rise;
+        
+        previousMagnitudes[(size_t) bin] = magnitude;
+    }
+}
+
+void OnsetDetector::detectOnset(float minimumFlux)
+{
+    float flux = std::sqrt(fluxSquared);
+    
+    if (flux >= minimumFlux && flux > meanFlux * adaptiveThresholdRatio)
+        onsetSamplesRemaining = hopSize;
+    
+    meanFlux += meanFluxCoeff * (flux - meanFlux);
+}
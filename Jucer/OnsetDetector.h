@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Spectral-flux onset detector. Samples are collected into an overlapping
+// analysis frame, and once per hop the frame is compared with the previous
+// spectrum.
+//
+// The per-hop work is split into evenly spaced stages so no single sample (and
+// so no single block) pays for a whole transform. The frame's FFT is computed
+// by decimation in time: numSubTransforms FFTs of size fftSize / numSubTransforms,
+// each in its own stage, followed by twiddle-combine stages that also
+// accumulate the flux. Whatever the host block size, a block carries at most
+// about one stage per stageInterval samples it contains, i.e. roughly
+// 1 / numSubTransforms of the full FFT for blocks shorter than stageInterval.
+class OnsetDetector
+{
+public:
+    OnsetDetector() = default;
+    
+    // Allocates all buffers; call from prepareToPlay only
+    void prepare(double sampleRate);
+    void reset();
+    
+    // Feeds one mono sample. Returns true for one hop after an onset is found.
+    // minimumFlux is the smallest rectified flux (linear gain) that counts as an onset.
+    bool processSample(float sample, float minimumFlux);
+    
+    // Delay between an onset in the input and processSample() reporting it
+    int getLatencySamples() const { return fftSize / 2 + hopSize; }
+    
+private:
+    using Complex = juce::dsp::Complex<float>;
+    
+    static constexpr int numSubTransforms = 4;
+    static constexpr int numCombineStages = 4;
+    static constexpr int numStages = 1 + numSubTransforms + numCombineStages;
+    
+    void runStage(int stage, float minimumFlux);
+    void captureFrame();
+    void computeSubTransform(int index);
+    void combineAndAccumulateFlux(int firstBin, int endBin);
+    void detectOnset(float minimumFlux);
+    
+    std::unique_ptr<juce::dsp::FFT> subFft;
+    int fftSize = 0;
+    int subFftSize = 0;
+    int hopSize = 0;
+    int stageInterval = 1;
+    
+    std::vector<float> inputFrame;      // circular buffer of the last fftSize samples
+    std::vector<float> window;
+    std::vector<float> windowedFrame;
+    std::vector<Complex> subInput;
+    std::vector<Complex> subSpectra;    // numSubTransforms * subFftSize
+    std::vector<Complex> twiddles;      // exp(-2 pi i m / fftSize)
+    std::vector<float> previousMagnitudes;
+    int inputPosition = 0;
+    int hopPosition = 0;
+    int nextStage = 0;
+    
+    float magnitudeScale = 1.0f;
+    float fluxSquared = 0.0f;
+    float meanFlux = 0.0f;
+    int onsetSamplesRemaining = 0;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OnsetDetector)
+};
@@ -5,7 +5,12 @@
 LevelMeter::LevelMeter(ThresholdTriggerAudioProcessor& processor)
     : audioProcessor(processor)
 {
-    startTimerHz(60); // 60 FPS refresh rate
+    refreshScheduler->addClient(*this, *this);
+}
+
+LevelMeter::~LevelMeter()
+{
+    refreshScheduler->removeClient(*this);
 }
 
 void LevelMeter::paint(juce::Graphics& g)
@@ -23,8 +28,7 @@ void LevelMeter::paint(juce::Graphics& g)
     // Level bar
     if (currentLevel > 0.0f)
     {
-        float levelHeight = juce::jmap(juce::Decibels::gainToDecibels(currentLevel), 
-                                      -60.0f, 0.0f, 0.0f, bounds.getHeight());
+        float levelHeight = lookupTables->meterPositionForGain(currentLevel) * bounds.getHeight();
         
         juce::Rectangle<float> levelRect(bounds.getX() + 2, 
                                         bounds.getBottom() - levelHeight - 2,
@@ -59,18 +63,158 @@ void LevelMeter::resized()
 {
 }
 
-void LevelMeter::timerCallback()
+void LevelMeter::refresh()
 {
     currentLevel = audioProcessor.getCurrentLevel();
     isTriggered = audioProcessor.getTriggerState();
     repaint();
 }
 
+//==============================================================================
+ScopeDisplay::ScopeDisplay(ThresholdTriggerAudioProcessor& processor)
+    : audioProcessor(processor),
+      incomingColumns(ThresholdTriggerAudioProcessor::scopeFifoSize)
+{
+    refreshScheduler->addClient(*this, *this);
+}
+
+ScopeDisplay::~ScopeDisplay()
+{
+    refreshScheduler->removeClient(*this);
+}
+
+float ScopeDisplay::levelToY(float gain, float height) const
+{
+    return (1.0f - lookupTables->meterPositionForGain(gain)) * (height - 1.0f);
+}
+
+void ScopeDisplay::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+    
+    g.setColour(scopeBackgroundColour);
+    g.fillRoundedRectangle(bounds, 4.0f);
+    
+    if (historyImage.isValid())
+        g.drawImageAt(historyImage, 2, 2);
+    
+    // Border
+    g.setColour(juce::Colour(0xff404040));
+    g.drawRoundedRectangle(bounds, 4.0f, 1.0f);
+    
+    // Threshold line is drawn live so it follows the slider without redrawing history
+    float thresholdY = 2.0f + levelToY(lookupTables->decibelsToGain(thresholdLevel),
+                                       (float) historyImage.getHeight());
+    
+    g.setColour(juce::Colour(0xffFF5722)); // Orange threshold line
+    g.drawLine(bounds.getX() + 2, thresholdY, bounds.getRight() - 2, thresholdY, 1.0f);
+}
+
+void ScopeDisplay::resized()
+{
+    auto area = getLocalBounds().reduced(2);
+    
+    if (area.isEmpty())
+    {
+        historyImage = {};
+        return;
+    }
+    
+    historyImage = juce::Image(juce::Image::RGB, area.getWidth(), area.getHeight(), false);
+    clearHistory();
+}
+
+void ScopeDisplay::visibilityChanged()
+{
+    if (isVisible())
+        discardQueuedColumns = true;
+}
+
+void ScopeDisplay::clearHistory()
+{
+    if (historyImage.isValid())
+    {
+        historyImage.clear(historyImage.getBounds(), scopeBackgroundColour);
+        lastEnvelopeY = (float) historyImage.getHeight() - 1.0f;
+    }
+}
+
+void ScopeDisplay::refresh()
+{
+    int numColumns = audioProcessor.popScopeColumns(incomingColumns.data(), (int) incomingColumns.size());
+    
+    // The scheduler only refreshes us while showing, so a long gap means we
+    // were hidden (e.g. editor window minimised) and the queue holds old audio
+    auto now = juce::Time::getMillisecondCounter();
+    bool stale = discardQueuedColumns || now - lastRefreshMs > staleGapMs;
+    lastRefreshMs = now;
+    discardQueuedColumns = false;
+    
+    if (stale)
+    {
+        clearHistory();
+        repaint();
+        return;
+    }
+    
+    if (numColumns == 0 || ! historyImage.isValid())
+        return;
+    
+    drawColumns(incomingColumns.data(), numColumns);
+    repaint();
+}
+
+void ScopeDisplay::drawColumns(const ScopeColumn* columns, int numColumns)
+{
+    int width = historyImage.getWidth();
+    int height = historyImage.getHeight();
+    float imageHeight = (float) height;
+    
+    // Only the newest columns that still fit on screen need drawing
+    int firstColumn = juce::jmax(0, numColumns - width);
+    int numNewColumns = numColumns - firstColumn;
+    
+    // Scroll the existing history left by the number of new columns
+    if (numNewColumns < width)
+        historyImage.moveImageSection(0, 0, numNewColumns, 0, width - numNewColumns, height);
+    
+    int startX = width - numNewColumns;
+    
+    juce::Graphics g(historyImage);
+    g.setColour(scopeBackgroundColour);
+    g.fillRect(startX, 0, numNewColumns, height);
+    
+    for (int i = 0; i < numNewColumns; ++i)
+    {
+        const auto& column = columns[firstColumn + i];
+        int x = startX + i;
+        
+        // Trigger marker
+        if (column.triggerEdge)
+        {
+            g.setColour(juce::Colour(0xffFFEB3B).withAlpha(0.8f));
+            g.drawVerticalLine(x, 0.0f, imageHeight);
+        }
+        
+        // Min/max input level
+        float maxY = levelToY(column.maxLevel, imageHeight);
+        float minY = levelToY(column.minLevel, imageHeight);
+        g.setColour(juce::Colour(0xff2196F3));
+        g.drawVerticalLine(x, maxY, minY + 1.0f);
+        
+        // Envelope (linear gain, full height = 1.0)
+        float envelopeY = (1.0f - column.envelope) * (imageHeight - 1.0f);
+        g.setColour(juce::Colour(0xff4CAF50));
+        g.drawLine((float) x - 1.0f, lastEnvelopeY, (float) x, envelopeY, 1.5f);
+        lastEnvelopeY = envelopeY;
+    }
+}
+
 //==============================================================================
 ThresholdTriggerAudioProcessorEditor::ThresholdTriggerAudioProcessorEditor (ThresholdTriggerAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p), levelMeter(p)
+    : AudioProcessorEditor (&p), audioProcessor (p), levelMeter(p), scopeDisplay(p)
 {
-    setSize (400, 300);
+    setSize (560, 460);
     
     // Setup sliders and labels
     setupSlider(thresholdSlider, thresholdLabel, "Threshold");
@@ -108,6 +252,67 @@ ThresholdTriggerAudioProcessorEditor::ThresholdTriggerAudioProcessorEditor (Thre
     triggerModeLabel.setColour(juce::Label::textColourId, textColour);
     triggerModeLabel.setJustificationType(juce::Justification::centred);
     
+    // Setup trigger source combo
+    addAndMakeVisible(triggerSourceCombo);
+    addAndMakeVisible(triggerSourceLabel);
+    
+    triggerSourceCombo.addItem("Level / MIDI", 1);
+    triggerSourceCombo.addItem("Onset", 2);
+    triggerSourceCombo.addItem("Bus", 3);
+    triggerSourceCombo.setColour(juce::ComboBox::backgroundColourId, juce::Colour(0xff1a1a1a));
+    triggerSourceCombo.setColour(juce::ComboBox::textColourId, textColour);
+    triggerSourceCombo.setColour(juce::ComboBox::outlineColourId, juce::Colour(0xff404040));
+    triggerSourceCombo.setColour(juce::ComboBox::arrowColourId, sliderColour);
+    
+    triggerSourceLabel.setText("Trigger Source", juce::dontSendNotification);
+    triggerSourceLabel.setFont(juce::Font(12.0f));
+    triggerSourceLabel.setColour(juce::Label::textColourId, textColour);
+    triggerSourceLabel.setJustificationType(juce::Justification::centred);
+    
+    // Setup control rate combo
+    addAndMakeVisible(controlRateCombo);
+    addAndMakeVisible(controlRateLabel);
+    
+    controlRateCombo.addItem("Per Sample", 1);
+    controlRateCombo.addItem("8 Samples", 2);
+    controlRateCombo.addItem("16 Samples", 3);
+    controlRateCombo.setColour(juce::ComboBox::backgroundColourId, juce::Colour(0xff1a1a1a));
+    controlRateCombo.setColour(juce::ComboBox::textColourId, textColour);
+    controlRateCombo.setColour(juce::ComboBox::outlineColourId, juce::Colour(0xff404040));
+    controlRateCombo.setColour(juce::ComboBox::arrowColourId, sliderColour);
+    
+    controlRateLabel.setText("Control Rate", juce::dontSendNotification);
+    controlRateLabel.setFont(juce::Font(12.0f));
+    controlRateLabel.setColour(juce::Label::textColourId, textColour);
+    controlRateLabel.setJustificationType(juce::Justification::centred);
+    
+    // Setup trigger bus controls
+    addAndMakeVisible(busChannelLabel);
+    addAndMakeVisible(busChannelEditor);
+    addAndMakeVisible(busPublishToggle);
+    addAndMakeVisible(busStatusLabel);
+    
+    busChannelLabel.setText("Bus Channel", juce::dontSendNotification);
+    busChannelLabel.setFont(juce::Font(12.0f));
+    busChannelLabel.setColour(juce::Label::textColourId, textColour);
+    busChannelLabel.setJustificationType(juce::Justification::centredRight);
+    
+    busChannelEditor.setText(audioProcessor.getTriggerBusChannel(), juce::dontSendNotification);
+    busChannelEditor.setColour(juce::TextEditor::backgroundColourId, juce::Colour(0xff1a1a1a));
+    busChannelEditor.setColour(juce::TextEditor::textColourId, textColour);
+    busChannelEditor.setColour(juce::TextEditor::outlineColourId, juce::Colour(0xff404040));
+    busChannelEditor.onReturnKey = [this]() { audioProcessor.setTriggerBusChannel(busChannelEditor.getText().trim()); };
+    busChannelEditor.onFocusLost = busChannelEditor.onReturnKey;
+    
+    busPublishToggle.setButtonText("Publish");
+    busPublishToggle.setColour(juce::ToggleButton::textColourId, textColour);
+    busPublishToggle.setColour(juce::ToggleButton::tickColourId, sliderColour);
+    busPublishToggle.setColour(juce::ToggleButton::tickDisabledColourId, juce::Colour(0xff404040));
+    
+    busStatusLabel.setFont(juce::Font(12.0f));
+    busStatusLabel.setColour(juce::Label::textColourId, juce::Colour(0xffFF5722));
+    busStatusLabel.setJustificationType(juce::Justification::centredLeft);
+    
     // Create parameter attachments
     thresholdAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.getValueTreeState(), "threshold", thresholdSlider);
@@ -119,22 +324,55 @@ ThresholdTriggerAudioProcessorEditor::ThresholdTriggerAudioProcessorEditor (Thre
         audioProcessor.getValueTreeState(), "retrigger", retriggerToggle);
     triggerModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
         audioProcessor.getValueTreeState(), "midiMode", triggerModeCombo);
+    triggerSourceAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getValueTreeState(), "triggerSource", triggerSourceCombo);
+    controlRateAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getValueTreeState(), "controlRate", controlRateCombo);
+    busPublishAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getValueTreeState(), "busPublish", busPublishToggle);
     
     // Setup level meter
     addAndMakeVisible(levelMeter);
     
-    // Update threshold display on level meter
+    // Setup scope
+    addAndMakeVisible(scopeDisplay);
+    
+    // Update threshold display on level meter and scope
     thresholdSlider.onValueChange = [this]()
     {
         levelMeter.setThreshold(thresholdSlider.getValue());
+        scopeDisplay.setThreshold(thresholdSlider.getValue());
     };
     
     // Initial threshold value
     levelMeter.setThreshold(thresholdSlider.getValue());
+    scopeDisplay.setThreshold(thresholdSlider.getValue());
+    
+    refreshScheduler->addClient(*this, *this);
 }
 
 ThresholdTriggerAudioProcessorEditor::~ThresholdTriggerAudioProcessorEditor()
 {
+    refreshScheduler->removeClient(*this);
+}
+
+void ThresholdTriggerAudioProcessorEditor::refresh()
+{
+    // Warn when this instance can't publish, or when this subscriber has no
+    // publisher or couldn't read what it needed from the bus
+    juce::String status;
+    
+    if (audioProcessor.isBusPublishBlocked())
+        status = "Can't publish in Bus mode";
+    else if (audioProcessor.isBusPublishRefused())
+        status = "Channel has a publisher";
+    else if (audioProcessor.isBusSubscriberWithoutPublisher())
+        status = "No publisher";
+    else if (audioProcessor.isBusSubscriberStarved())
+        status = "No bus data";
+    
+    if (busStatusLabel.getText() != status)
+        busStatusLabel.setText(status, juce::dontSendNotification);
 }
 
 void ThresholdTriggerAudioProcessorEditor::setupSlider(juce::Slider& slider, juce::Label& label, const juce::String& labelText)
@@ -177,6 +415,20 @@ void ThresholdTriggerAudioProcessorEditor::resized()
     auto bounds = getLocalBounds();
     bounds.removeFromTop(60); // Space for title
     
+    // Scope area along the bottom
+    auto scopeBounds = bounds.removeFromBottom(120);
+    scopeBounds.reduce(10, 10);
+    scopeDisplay.setBounds(scopeBounds);
+    
+    // Trigger bus row above the scope
+    auto busBounds = bounds.removeFromBottom(40).reduced(10, 8);
+    busChannelLabel.setBounds(busBounds.removeFromLeft(80));
+    busBounds.removeFromLeft(6);
+    busChannelEditor.setBounds(busBounds.removeFromLeft(70));
+    busBounds.removeFromLeft(10);
+    busPublishToggle.setBounds(busBounds.removeFromLeft(80));
+    busStatusLabel.setBounds(busBounds);
+    
     // Level meter area
     auto meterBounds = bounds.removeFromRight(80);
     meterBounds.reduce(10, 10);
@@ -205,11 +457,12 @@ void ThresholdTriggerAudioProcessorEditor::resized()
                          sliderWidth - 10, 
                          sliderHeight);
     
-    // Position retrigger toggle and trigger mode combo below sliders
+    // Position retrigger toggle, trigger mode, source and control rate combos below sliders
     auto toggleBounds = controlsBounds.removeFromBottom(80);
+    auto columnWidth = toggleBounds.getWidth() / 4;
     
-    // Left side: retrigger toggle
-    auto retriggerBounds = toggleBounds.removeFromLeft(toggleBounds.getWidth() / 2);
+    // Retrigger toggle
+    auto retriggerBounds = toggleBounds.removeFromLeft(columnWidth);
     retriggerToggle.setBounds(retriggerBounds.getX() + (retriggerBounds.getWidth() - 100) / 2, 
                              retriggerBounds.getY() + 10, 
                              100, 24);
@@ -219,14 +472,36 @@ void ThresholdTriggerAudioProcessorEditor::resized()
                             retriggerToggle.getWidth(),
                             16);
     
-    // Right side: trigger mode combo
-    auto modeBounds = toggleBounds;
-    triggerModeCombo.setBounds(modeBounds.getX() + (modeBounds.getWidth() - 120) / 2,
+    // Trigger mode combo
+    auto modeBounds = toggleBounds.removeFromLeft(columnWidth);
+    triggerModeCombo.setBounds(modeBounds.getX() + (modeBounds.getWidth() - 100) / 2,
                               modeBounds.getY() + 10,
-                              120, 24);
+                              100, 24);
     
     triggerModeLabel.setBounds(triggerModeCombo.getX(),
                               triggerModeCombo.getBottom() + 2,
                               triggerModeCombo.getWidth(),
                               16);
+    
+    // Trigger source combo
+    auto sourceBounds = toggleBounds.removeFromLeft(columnWidth);
+    triggerSourceCombo.setBounds(sourceBounds.getX() + (sourceBounds.getWidth() - 100) / 2,
+                                sourceBounds.getY() + 10,
+                                100, 24);
+    
+    triggerSourceLabel.setBounds(triggerSourceCombo.getX(),
+                                triggerSourceCombo.getBottom() + 2,
+                                triggerSourceCombo.getWidth(),
+                                16);
+    
+    // Control rate combo
+    auto rateBounds = toggleBounds;
+    controlRateCombo.setBounds(rateBounds.getX() + (rateBounds.getWidth() - 100) / 2,
+                              rateBounds.getY() + 10,
+                              100, 24);
+    
+    controlRateLabel.setBounds(controlRateCombo.getX(),
+                              controlRateCombo.getBottom() + 2,
+                              controlRateCombo.getWidth(),
+                              16);
 }
\ No newline at end of file
@@ -4,19 +4,23 @@
 #include "PluginProcessor.h"
 
 //==============================================================================
-class LevelMeter : public juce::Component, public juce::Timer
+class LevelMeter : public juce::Component, private SharedRefreshScheduler::Client
 {
 public:
     LevelMeter(ThresholdTriggerAudioProcessor& processor);
+    ~LevelMeter() override;
     
     void paint(juce::Graphics& g) override;
     void resized() override;
-    void timerCallback() override;
     
     void setThreshold(float threshold) { thresholdLevel = threshold; }
     
 private:
+    void refresh() override;
+    
     ThresholdTriggerAudioProcessor& audioProcessor;
+    juce::SharedResourcePointer<SharedRefreshScheduler> refreshScheduler;
+    juce::SharedResourcePointer<SharedLookupTables> lookupTables;
     float currentLevel = 0.0f;
     float thresholdLevel = 0.0f;
     bool isTriggered = false;
@@ -25,7 +29,50 @@ private:
 };
 
 //==============================================================================
-class ThresholdTriggerAudioProcessorEditor : public juce::AudioProcessorEditor
+// Scrolling history of input level, envelope and trigger edges. New columns are
+// drawn once into a persistent image which is scrolled, so a frame only costs
+// as much as the columns that arrived since the last one.
+class ScopeDisplay : public juce::Component, private SharedRefreshScheduler::Client
+{
+public:
+    ScopeDisplay(ThresholdTriggerAudioProcessor& processor);
+    ~ScopeDisplay() override;
+    
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void visibilityChanged() override;
+    
+    void setThreshold(float threshold) { thresholdLevel = threshold; repaint(); }
+    
+private:
+    using ScopeColumn = ThresholdTriggerAudioProcessor::ScopeColumn;
+    
+    void refresh() override;
+    void drawColumns(const ScopeColumn* columns, int numColumns);
+    void clearHistory();
+    float levelToY(float gain, float height) const;
+    
+    ThresholdTriggerAudioProcessor& audioProcessor;
+    juce::SharedResourcePointer<SharedRefreshScheduler> refreshScheduler;
+    juce::SharedResourcePointer<SharedLookupTables> lookupTables;
+    juce::Image historyImage;
+    std::vector<ScopeColumn> incomingColumns;
+    float lastEnvelopeY = 0.0f;
+    float thresholdLevel = 0.0f;
+    
+    // Columns queued while we weren't on screen are stale and get dropped
+    static constexpr juce::uint32 staleGapMs = 250;
+    juce::uint32 lastRefreshMs = 0;
+    bool discardQueuedColumns = true;
+    
+    juce::Colour scopeBackgroundColour = juce::Colour(0xff1a1a1a);
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScopeDisplay)
+};
+
+//==============================================================================
+class ThresholdTriggerAudioProcessorEditor : public juce::AudioProcessorEditor,
+                                             private SharedRefreshScheduler::Client
 {
 public:
     ThresholdTriggerAudioProcessorEditor (ThresholdTriggerAudioProcessor&);
@@ -36,7 +83,10 @@ public:
     void resized() override;
 
 private:
+    void refresh() override;
+    
     ThresholdTriggerAudioProcessor& audioProcessor;
+    juce::SharedResourcePointer<SharedRefreshScheduler> refreshScheduler;
     
     // Controls
     juce::Slider thresholdSlider;
@@ -44,12 +94,20 @@ private:
     juce::Slider decaySlider;
     juce::ToggleButton retriggerToggle;
     juce::ComboBox triggerModeCombo;
+    juce::ComboBox triggerSourceCombo;
+    juce::ComboBox controlRateCombo;
+    juce::TextEditor busChannelEditor;
+    juce::ToggleButton busPublishToggle;
     
     juce::Label thresholdLabel;
     juce::Label attackLabel;
     juce::Label decayLabel;
     juce::Label retriggerLabel;
     juce::Label triggerModeLabel;
+    juce::Label triggerSourceLabel;
+    juce::Label controlRateLabel;
+    juce::Label busChannelLabel;
+    juce::Label busStatusLabel;
     
     // Attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> thresholdAttachment;
@@ -57,10 +115,16 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> decayAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> retriggerAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> triggerModeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> triggerSourceAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> controlRateAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> busPublishAttachment;
     
     // Level meter
     LevelMeter levelMeter;
     
+    // Scrolling scope
+    ScopeDisplay scopeDisplay;
+    
     // Styling
     juce::Colour backgroundColour = juce::Colour(0xff2d2d2d);
     juce::Colour sliderColour = juce::Colour(0xff4a90e2);
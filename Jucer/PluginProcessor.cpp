@@ -28,6 +28,11 @@ ThresholdTriggerAudioProcessor::ThresholdTriggerAudioProcessor()
     decayParam = valueTreeState.getRawParameterValue("decay");
     retriggerParam = valueTreeState.getRawParameterValue("retrigger");
     midiModeParam = valueTreeState.getRawParameterValue("midiMode");
+    triggerSourceParam = valueTreeState.getRawParameterValue("triggerSource");
+    busPublishParam = valueTreeState.getRawParameterValue("busPublish");
+    controlRateParam = valueTreeState.getRawParameterValue("controlRate");
+    
+    setTriggerBusChannel("A");
 /*
     if (logSocket.connect("127.0.0.1", 6000))
         {
@@ -35,12 +40,16 @@ ThresholdTriggerAudioProcessor::ThresholdTriggerAudioProcessor()
         }
         
 */
+    valueTreeState.addParameterListener("triggerSource", this);
           pluginVersion = ProjectInfo::versionString;
           
 }
 
 ThresholdTriggerAudioProcessor::~ThresholdTriggerAudioProcessor()
 {
+    valueTreeState.removeParameterListener("triggerSource", this);
+    cancelPendingUpdate();
+    updatePublisherClaim(nullptr);
 }
 
 //==============================================================================
@@ -85,6 +94,27 @@ juce::AudioProcessorValueTreeState::ParameterLayout ThresholdTriggerAudioProcess
         0  // Default to Audio mode
     ));
     
+    // Kept separate from midiMode so existing automation of that choice keeps its meaning
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        "triggerSource",
+        "Trigger Source",
+        juce::StringArray { "Level / MIDI", "Onset", "Bus" },
+        0  // Default to the Trigger Mode selection
+    ));
+    
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        "busPublish",
+        "Publish To Bus",
+        false
+    ));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        "controlRate",
+        "Control Rate",
+        juce::StringArray { "Per Sample", "8 Samples", "16 Samples" },
+        0  // Default to per-sample processing
+    ));
+    
     return layout;
 }
 
@@ -119,7 +149,16 @@ bool ThresholdTriggerAudioProcessor::isMidiEffect() const
 
 double ThresholdTriggerAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // The output never outlasts the input, but the envelope keeps running after
+    // the input stops. Report the worst case time for it to settle back to Idle
+    // (attack up to 0.99, then decay down to 0.001) so a host that suspends on
+    // silence never resumes us mid-envelope. In Onset and Bus modes the audio
+    // path is delayed by the source latency, which adds to the tail.
+    double attackSeconds = *attackParam * 0.001;
+    double decaySeconds = *decayParam * 0.001;
+    double sourceDelaySeconds = getReportedLatencySamples() / sampleRate;
+    
+    return attackSeconds * std::log(100.0) + decaySeconds * std::log(1000.0) + sourceDelaySeconds;
 }
 
 int ThresholdTriggerAudioProcessor::getNumPrograms()
@@ -150,10 +189,37 @@ void ThresholdTriggerAudioProcessor::prepareToPlay (double sampleRate, int sampl
 {
     this->sampleRate = sampleRate;
     updateCoefficients();
+    
+    // Onset analysis, bus look-behind and the matching delay on the audio path.
+    // Bus subscribers read one maximum block behind so the publisher has always
+    // written that range, whichever order the host processes the instances in,
+    // plus the onset latency, since an Onset publisher stamps its envelope that
+    // far back to line it up with the audio it was detected in.
+    onsetDetector.prepare(sampleRate);
+    onsetLatencySamples.store(onsetDetector.getLatencySamples());
+    busLookBehindSamples.store(juce::jmax(1, samplesPerBlock) + onsetLatencySamples.load());
+    
+    sourceDelay.prepare({ sampleRate, (juce::uint32) samplesPerBlock, (juce::uint32) juce::jmax(1, getTotalNumInputChannels()) });
+    sourceDelay.setMaximumDelayInSamples(juce::jmax(onsetLatencySamples.load(), busLookBehindSamples.load()));
+    activeSourceDelaySamples = 0;
+
+    onsetModeActive = getTriggerMode() == 3;
+    onsetTriggered = false;
+    wasOnsetTriggered = false;
+    setLatencySamples(getReportedLatencySamples());
+    
+    scopeSamplesPerColumn = juce::jmax(1, juce::roundToInt(sampleRate * scopeSecondsPerColumn));
+    pendingColumnSamples = 0;
+    scopeSmoothingSamples = static_cast<float>(sampleRate * scopeSmoothingSeconds);
+    for (size_t i = 0; i < std::size(controlIntervals); ++i)
+        scopeSmoothingCoeffs[i] = 1.0f - std::exp(-static_cast<float>(controlIntervals[i]) / scopeSmoothingSamples);
+    scopeMeanSquare = 0.0f;
 }
 
 void ThresholdTriggerAudioProcessor::releaseResources()
 {
+    // Let another instance publish to the channel while we're not processing
+    updatePublisherClaim(nullptr);
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -177,20 +243,55 @@ bool ThresholdTriggerAudioProcessor::isBusesLayoutSupported (const BusesLayout&
 }
 #endif
 
-void ThresholdTriggerAudioProcessor::updateCoefficients()
+void ThresholdTriggerAudioProcessor::updateCoefficients(int samplesPerStep)
 {
     float attackTimeMs = *attackParam;
     float decayTimeMs = *decayParam;
+    float step = static_cast<float>(samplesPerStep);
     
-    // Convert time constants to coefficients
-    attackCoeff = 1.0f - std::exp(-1.0f / (attackTimeMs * 0.001f * sampleRate));
-    decayCoeff = 1.0f - std::exp(-1.0f / (decayTimeMs * 0.001f * sampleRate));
+    // Convert time constants to coefficients for one envelope step
+    attackCoeff = 1.0f - std::exp(-step / (attackTimeMs * 0.001f * sampleRate));
+    decayCoeff = 1.0f - std::exp(-step / (decayTimeMs * 0.001f * sampleRate));
+}
+
+int ThresholdTriggerAudioProcessor::getTriggerMode() const
+{
+    // 0=Audio, 1=MIDI, 2=Audio+MIDI (from midiMode), 3=Onset, 4=Bus (from triggerSource)
+    switch (static_cast<int>(*triggerSourceParam))
+    {
+        case 1:  return 3;
+        case 2:  return 4;
+        default: return static_cast<int>(*midiModeParam);
+    }
+}
+
+int ThresholdTriggerAudioProcessor::getReportedLatencySamples() const
+{
+    switch (getTriggerMode())
+    {
+        case 3:  return onsetLatencySamples.load();
+        case 4:  return busLookBehindSamples.load();
+        default: return 0;
+    }
+}
+
+void ThresholdTriggerAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    juce::ignoreUnused(parameterID, newValue);
+    
+    // May arrive on the audio thread; notify the host from the message thread
+    triggerAsyncUpdate();
+}
+
+void ThresholdTriggerAudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples(getReportedLatencySamples());
 }
 
 float ThresholdTriggerAudioProcessor::processEnvelope(float inputLevel)
 {
     bool allowRetrigger = *retriggerParam > 0.5f;
-    int triggerMode = static_cast<int>(*midiModeParam);  // 0=Audio, 1=MIDI, 2=Audio+MIDI
+    int triggerMode = getTriggerMode();  // 0=Audio, 1=MIDI, 2=Audio+MIDI, 3=Onset, 4=Bus
     
     // Determine trigger source based on mode
     bool shouldTrigger = false;
@@ -215,6 +316,16 @@ float ThresholdTriggerAudioProcessor::processEnvelope(float inputLevel)
             shouldTrigger = isTriggered || midiTriggered;
             wasTriggeredPreviously = wasTriggered || wasMidiTriggered;
            
+            break;
+        case 3: // Spectral-flux onset
+            shouldTrigger = onsetTriggered;
+            wasTriggeredPreviously = wasOnsetTriggered;
+            
+            break;
+        case 4: // Trigger bus subscriber
+            shouldTrigger = busTriggered;
+            wasTriggeredPreviously = wasBusTriggered;
+            
             break;
     }
    /* DBG("triggerMode: " << triggerMode
@@ -228,11 +339,15 @@ float ThresholdTriggerAudioProcessor::processEnvelope(float inputLevel)
         << ", envelopeState: " << envelopeState 
         << ", envelopeLevel: " << envelopeLevel);
     */
+    triggerEdgeDetected = newTriggerDetected;
+    
     // Trigger logic: start attack when new trigger is detected
     if (newTriggerDetected)
     {
         envelopeState = Attack;
-       
+        
+        // An onset is only a momentary pulse, so let it run the full attack
+        attackLatched = triggerMode == 3;
     }
     
     // Process envelope based on current state
@@ -243,9 +358,10 @@ float ThresholdTriggerAudioProcessor::processEnvelope(float inputLevel)
             envelopeLevel += attackCoeff * (1.0f - envelopeLevel);
             
             // Switch to decay when we reach near-peak or trigger stops
-            if (envelopeLevel >= 0.99f || !shouldTrigger)
+            if (envelopeLevel >= 0.99f || (!shouldTrigger && !attackLatched))
             {
                 envelopeState = Decay;
+                attackLatched = false;
             }
             break;
             
@@ -276,6 +392,293 @@ float ThresholdTriggerAudioProcessor::processEnvelope(float inputLevel)
     return envelopeLevel;
 }
 
+void ThresholdTriggerAudioProcessor::pushScopeSamples(float level, float envelope, bool triggerEdge, int numSamples)
+{
+    // Smooth the level so a column's min/max shows how the level moved rather
+    // than dropping to zero at every zero crossing of the waveform. The pending
+    // column holds mean squares until it's flushed. Full control-rate steps use
+    // the coefficients from prepareToPlay; only partial steps and idle blocks
+    // compute their own.
+    float smoothingCoeff = -1.0f;
+    
+    for (size_t i = 0; i < std::size(controlIntervals); ++i)
+        if (controlIntervals[i] == numSamples)
+            smoothingCoeff = scopeSmoothingCoeffs[i];
+    
+    if (smoothingCoeff < 0.0f)
+        smoothingCoeff = 1.0f - std::exp(-static_cast<float>(numSamples) / scopeSmoothingSamples);
+    scopeMeanSquare += smoothingCoeff * (level * level - scopeMeanSquare);
+    
+    while (numSamples > 0)
+    {
+        if (pendingColumnSamples == 0)
+        {
+            pendingColumn = { scopeMeanSquare, scopeMeanSquare, envelope, triggerEdge };
+        }
+        else
+        {
+            pendingColumn.minLevel = juce::jmin(pendingColumn.minLevel, scopeMeanSquare);
+            pendingColumn.maxLevel = juce::jmax(pendingColumn.maxLevel, scopeMeanSquare);
+            pendingColumn.envelope = envelope;
+            pendingColumn.triggerEdge = pendingColumn.triggerEdge || triggerEdge;
+        }
+        
+        int samplesTaken = juce::jmin(numSamples, scopeSamplesPerColumn - pendingColumnSamples);
+        pendingColumnSamples += samplesTaken;
+        numSamples -= samplesTaken;
+        triggerEdge = false;
+        
+        if (pendingColumnSamples < scopeSamplesPerColumn)
+            return;
+        
+        pendingColumnSamples = 0;
+        pendingColumn.minLevel = std::sqrt(pendingColumn.minLevel);
+        pendingColumn.maxLevel = std::sqrt(pendingColumn.maxLevel);
+        
+        // Drop the column if the editor isn't draining the FIFO (e.g. editor closed)
+        const auto scope = scopeFifo.write(1);
+        
+        if (scope.blockSize1 > 0)
+            scopeColumns[(size_t) scope.startIndex1] = pendingColumn;
+        else if (scope.blockSize2 > 0)
+            scopeColumns[(size_t) scope.startIndex2] = pendingColumn;
+    }
+}
+
+bool ThresholdTriggerAudioProcessor::processIdleBlock(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages,
+                                                      int numInputChannels, float thresholdLinear)
+{
+    int triggerMode = getTriggerMode();
+    
+    // Only an idle gate can produce a silent block without running the detector.
+    // The onset detector and the bus subscriber have to see every sample.
+    if (envelopeState != Idle || triggerMode >= 3)
+        return false;
+    
+    int numSamples = buffer.getNumSamples();
+    
+    // A note-on could open the gate; note-offs only need to update the MIDI state
+    bool finalMidiState = midiTriggered;
+    
+    for (const auto metadata : midiMessages)
+    {
+        auto message = metadata.getMessage();
+        
+        if (message.isNoteOn())
+        {
+            if (triggerMode != 0)
+                return false;
+            
+            finalMidiState = true;
+        }
+        else if (message.isNoteOff())
+        {
+            finalMidiState = false;
+        }
+    }
+    
+    // The per-sample RMS across channels never exceeds the block peak, so a
+    // peak below the threshold means no audio trigger can fire in this block
+    float blockPeak = 0.0f;
+    
+    if (! buffer.hasBeenCleared())
+        for (int channel = 0; channel < numInputChannels; ++channel)
+            blockPeak = juce::jmax(blockPeak, buffer.getMagnitude(channel, 0, numSamples));
+    
+    if (triggerMode != 1 && blockPeak >= thresholdLinear)
+        return false;
+    
+    // Nothing can trigger: output is silent, so skip the detector and envelope
+    // and just clear the block. Note this only saves our own work; JUCE's
+    // AudioProcessor API doesn't expose VST3 output silenceFlags, so the host
+    // isn't told the block is silent and downstream plugins still process it.
+    buffer.clear();
+    
+    currentLevel = blockPeak;
+    isTriggered = false;
+    wasTriggered = false;
+    midiTriggered = finalMidiState;
+    wasMidiTriggered = finalMidiState;
+    triggerEdgeDetected = false;
+    envelopeLevel = 0.0f;
+    
+    pushScopeSamples(blockPeak, 0.0f, false, numSamples);
+    
+    return true;
+}
+
+// Runs the detector and envelope once per sub-block of controlInterval samples.
+// The detector takes the peak of the cross-channel RMS over the sub-block, and MIDI
+// events inside it take effect at its start. The gain is ramped linearly from
+// the previous envelope value to the new one across the sub-block, so a
+// trigger edge can open the gate at most controlInterval - 1 samples early
+// (about 83 us at 192 kHz with 16 samples), and never late.
+void ThresholdTriggerAudioProcessor::processBlockAtControlRate(juce::AudioBuffer<float>& buffer,
+                                                               const juce::MidiBuffer& midiMessages,
+                                                               int numInputChannels, float thresholdLinear,
+                                                               int controlInterval,
+                                                               TriggerBus::Channel* publishChannel,
+                                                               juce::int64 blockTimestamp)
+{
+    int numSamples = buffer.getNumSamples();
+    auto midiIterator = midiMessages.cbegin();
+    std::array<float, maxControlInterval> gainRamp;
+    
+    for (int start = 0; start < numSamples; start += controlInterval)
+    {
+        int stepSamples = juce::jmin(controlInterval, numSamples - start);
+        
+        // A trailing partial sub-block advances the envelope by fewer samples
+        if (stepSamples != controlInterval)
+            updateCoefficients(stepSamples);
+        
+        // Apply this sub-block's MIDI. A note-on still counts even if released
+        // again before the sub-block ends, and a note-off followed by a note-on
+        // (a repeated note) has to retrigger even though the note looks held.
+        bool noteOnInStep = false;
+        bool noteOffBeforeNoteOn = false;
+        
+        for (; midiIterator != midiMessages.cend() && (*midiIterator).samplePosition < start + stepSamples; ++midiIterator)
+        {
+            auto message = (*midiIterator).getMessage();
+            
+            if (message.isNoteOn())
+            {
+                noteOffBeforeNoteOn = noteOffBeforeNoteOn || ! midiTriggered;
+                midiTriggered = true;
+                noteOnInStep = true;
+            }
+            else if (message.isNoteOff())
+            {
+                midiTriggered = false;
+            }
+        }
+        
+        bool finalMidiState = midiTriggered;
+        midiTriggered = midiTriggered || noteOnInStep;
+        
+        if (noteOffBeforeNoteOn)
+            wasMidiTriggered = false;
+        
+        // Peak over the sub-block of the same cross-channel RMS the per-sample
+        // path uses, so the threshold means the same at every control rate
+        std::array<float, maxControlInterval> sumOfSquares {};
+        for (int channel = 0; channel < numInputChannels; ++channel)
+        {
+            const float* channelData = buffer.getReadPointer(channel, start);
+            
+            for (int i = 0; i < stepSamples; ++i)
+                sumOfSquares[(size_t) i] += channelData[i] * channelData[i];
+        }
+        
+        float peakSumOfSquares = *std::max_element(sumOfSquares.begin(), sumOfSquares.begin() + stepSamples);
+        
+        currentLevel = std::sqrt(peakSumOfSquares / numInputChannels);
+        isTriggered = currentLevel >= thresholdLinear;
+        
+        float previousGain = envelopeLevel;
+        float envelopeOutput = processEnvelope(currentLevel);
+        pushScopeSamples(currentLevel, envelopeOutput, triggerEdgeDetected, stepSamples);
+        
+        // Interpolate the gain across the sub-block and apply it
+        float gainIncrement = (envelopeOutput - previousGain) / static_cast<float>(stepSamples);
+        for (int i = 0; i < stepSamples; ++i)
+            gainRamp[(size_t) i] = previousGain + gainIncrement * static_cast<float>(i + 1);
+        
+        for (int channel = 0; channel < numInputChannels; ++channel)
+            juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel, start), gainRamp.data(), stepSamples);
+        
+        if (publishChannel != nullptr)
+            for (int i = 0; i < stepSamples; ++i)
+                publishChannel->writeSample(blockTimestamp + start + i, gainRamp[(size_t) i],
+                                            triggerEdgeDetected && i == 0);
+        
+        // Store current states as "previous" for the next sub-block
+        wasTriggered = isTriggered;
+        wasMidiTriggered = midiTriggered;
+        midiTriggered = finalMidiState;
+    }
+    
+    if (publishChannel != nullptr)
+        publishChannel->endBlock(blockTimestamp + numSamples);
+}
+
+bool ThresholdTriggerAudioProcessor::getHostTimestamp(juce::int64& timestamp) const
+{
+    // The host timeline only lines instances up while it's moving; stopped
+    // hosts typically report the same position for every block
+    if (auto* playHead = getPlayHead())
+        if (auto position = playHead->getPosition())
+            if (position->getIsPlaying())
+                if (auto timeInSamples = position->getTimeInSamples())
+                {
+                    timestamp = *timeInSamples;
+                    return true;
+                }
+    
+    return false;
+}
+
+juce::int64 ThresholdTriggerAudioProcessor::getFreeRunningReadTimestamp(const TriggerBus::Channel& channel, int numSamples)
+{
+    // Without a running host timeline, follow the publisher's clock: start one
+    // look-behind behind what it has written, then advance contiguously. Resync
+    // if we drift out of the window the look-behind allows, but not while the
+    // publisher has stopped writing, or we'd replay its last samples forever.
+    auto writtenEnd = channel.getWrittenEnd();
+    auto lookBehind = (juce::int64) activeSourceDelaySamples;
+    bool publisherMoved = writtenEnd != busReadCursorWrittenEnd;
+    busReadCursorWrittenEnd = writtenEnd;
+    
+    if (! busReadCursorValid
+        || (publisherMoved && busReadCursor + numSamples > writtenEnd)
+        || busReadCursor < writtenEnd - 2 * lookBehind - numSamples)
+    {
+        busReadCursor = writtenEnd - lookBehind;
+        busReadCursorValid = true;
+    }
+    
+    auto timestamp = busReadCursor;
+    busReadCursor += numSamples;
+    return timestamp;
+}
+
+void ThresholdTriggerAudioProcessor::updatePublisherClaim(TriggerBus::Channel* wantedChannel)
+{
+    if (publishingChannel != wantedChannel && publishingChannel != nullptr)
+    {
+        publishingChannel->releasePublisher(this);
+        publishingChannel = nullptr;
+    }
+    
+    // Retried every block, so we take over once the other publisher lets go
+    if (wantedChannel != nullptr && publishingChannel == nullptr && wantedChannel->claimPublisher(this))
+        publishingChannel = wantedChannel;
+    
+    busPublishRefused.store(wantedChannel != nullptr && publishingChannel == nullptr, std::memory_order_relaxed);
+}
+
+void ThresholdTriggerAudioProcessor::setTriggerBusChannel(const juce::String& name)
+{
+    valueTreeState.state.setProperty("busChannel", name, nullptr);
+    busChannel.store(name.isNotEmpty() ? triggerBus->getChannel(name) : nullptr, std::memory_order_release);
+}
+
+juce::String ThresholdTriggerAudioProcessor::getTriggerBusChannel() const
+{
+    return valueTreeState.state.getProperty("busChannel").toString();
+}
+
+int ThresholdTriggerAudioProcessor::popScopeColumns(ScopeColumn* dest, int maxColumns)
+{
+    const auto scope = scopeFifo.read(juce::jmin(maxColumns, scopeFifo.getNumReady()));
+    
+    std::copy_n(scopeColumns.begin() + scope.startIndex1, scope.blockSize1, dest);
+    std::copy_n(scopeColumns.begin() + scope.startIndex2, scope.blockSize2, dest + scope.blockSize1);
+    
+    return scope.blockSize1 + scope.blockSize2;
+}
+
 void ThresholdTriggerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
@@ -286,11 +689,112 @@ void ThresholdTriggerAudioProcessor::processBlock (juce::AudioBuffer<float>& buf
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
+    // Control rate only applies to the level and MIDI detectors; onset analysis
+    // and bus subscription need every sample
+    int triggerMode = getTriggerMode();
+    int controlRateIndex = juce::jlimit(0, (int) std::size(controlIntervals) - 1, static_cast<int>(*controlRateParam));
+    int controlInterval = triggerMode < 3 ? controlIntervals[controlRateIndex] : 1;
+    
     // Update coefficients if parameters changed
-    updateCoefficients();
+    updateCoefficients(controlInterval);
     
     float thresholdDb = *thresholdParam;
-    float thresholdLinear = juce::Decibels::decibelsToGain(thresholdDb);
+    float thresholdLinear = lookupTables->decibelsToGain(thresholdDb);
+    
+    // Entering onset mode starts the analysis afresh; the latency change is
+    // reported from the message thread by handleAsyncUpdate
+    bool onsetMode = triggerMode == 3;
+    
+    if (onsetMode != onsetModeActive)
+    {
+        onsetModeActive = onsetMode;
+        onsetDetector.reset();
+        onsetTriggered = false;
+        wasOnsetTriggered = false;
+    }
+    
+    // Onset and Bus sources lag the audio, so the audio is delayed to match
+    int sourceDelaySamples = triggerMode == 3 ? onsetLatencySamples.load()
+                           : triggerMode == 4 ? busLookBehindSamples.load()
+                           : 0;
+    
+    if (sourceDelaySamples != activeSourceDelaySamples)
+    {
+        activeSourceDelaySamples = sourceDelaySamples;
+        sourceDelay.reset();
+        sourceDelay.setDelay((float) sourceDelaySamples);
+    }
+    
+    // Trigger bus: publishers and subscribers index the shared ring by block timestamp
+    int numSamples = buffer.getNumSamples();
+    auto* busChannelPtr = busChannel.load(std::memory_order_acquire);
+    // A Bus subscriber can't publish: its envelope lags its input by the look-behind,
+    // which a subscriber of ours couldn't make up with the same look-behind
+    bool wantsToPublish = busChannelPtr != nullptr && *busPublishParam > 0.5f;
+    busPublishBlocked.store(wantsToPublish && triggerMode == 4, std::memory_order_relaxed);
+    updatePublisherClaim(wantsToPublish && triggerMode != 4 ? busChannelPtr : nullptr);
+    bool publishToBus = publishingChannel != nullptr;
+    bool subscribeToBus = busChannelPtr != nullptr && triggerMode == 4;
+    juce::int64 blockTimestamp = 0;
+    juce::int64 busReadTimestamp = 0;
+    int busSamplesAvailable = 0;
+    
+    juce::int64 hostTimestamp = 0;
+    bool hasHostTimestamp = (publishToBus || subscribeToBus) && getHostTimestamp(hostTimestamp);
+    
+    // Our envelope belongs to the input from activeSourceDelaySamples ago (the
+    // onset latency), so stamp it with that time. While the transport is stopped
+    // the publisher runs its own clock on the channel instead.
+    if (publishToBus)
+        blockTimestamp = hasHostTimestamp ? hostTimestamp - activeSourceDelaySamples
+                                          : publishingChannel->getNextPublishTimestamp();
+    
+    if (subscribeToBus)
+    {
+        if (hasHostTimestamp)
+        {
+            busReadTimestamp = hostTimestamp - activeSourceDelaySamples;
+            busReadCursorValid = false;
+        }
+        else
+        {
+            busReadTimestamp = getFreeRunningReadTimestamp(*busChannelPtr, numSamples);
+        }
+        
+        busSamplesAvailable = busChannelPtr->getNumAvailable(busReadTimestamp, numSamples);
+    }
+    else
+    {
+        // Don't carry a stale bus trigger into the next time we subscribe
+        busReadCursorValid = false;
+        busTriggered = false;
+        wasBusTriggered = false;
+    }
+    
+    busSubscriberWithoutPublisher.store(subscribeToBus && ! busChannelPtr->hasPublisher(), std::memory_order_relaxed);
+    busSubscriberStarved.store(subscribeToBus && busSamplesAvailable < numSamples, std::memory_order_relaxed);
+    
+    if (publishToBus)
+        publishingChannel->beginBlock(blockTimestamp);
+    
+    // Skip the detector and envelope entirely for silent blocks of an idle gate
+    if (processIdleBlock(buffer, midiMessages, totalNumInputChannels, thresholdLinear))
+    {
+        if (publishToBus)
+        {
+            publishingChannel->writeSilence(blockTimestamp, numSamples);
+            publishingChannel->endBlock(blockTimestamp + numSamples);
+        }
+        
+        return;
+    }
+    
+    if (controlInterval > 1)
+    {
+        processBlockAtControlRate(buffer, midiMessages, totalNumInputChannels, thresholdLinear, controlInterval,
+                                  publishingChannel, blockTimestamp);
+        return;
+    }
     
     // Process each sample
     for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
@@ -319,14 +823,33 @@ void ThresholdTriggerAudioProcessor::processBlock (juce::AudioBuffer<float>& buf
     
         // Calculate RMS level across all channels
         float rmsSquared = 0.0f;
+        float monoSum = 0.0f;
         for (int channel = 0; channel < totalNumInputChannels; ++channel)
         {
             float sampleValue = buffer.getSample(channel, sample);
             rmsSquared += sampleValue * sampleValue;
+            monoSum += sampleValue;
         }
         
         currentLevel = std::sqrt(rmsSquared / totalNumInputChannels);
         
+        // Onset detection runs on the mono sum, only while it's the trigger source
+        if (onsetMode)
+            onsetTriggered = onsetDetector.processSample(monoSum / totalNumInputChannels, thresholdLinear);
+        
+        // Bus subscribers compare the publisher's envelope, one look-behind ago,
+        // with their own threshold. Unpublished samples count as untriggered.
+        // A publisher retrigger while its envelope is still above our threshold
+        // has no rising edge here, so it's taken from the published edge instead.
+        if (subscribeToBus)
+        {
+            busTriggered = sample < busSamplesAvailable
+                        && busChannelPtr->readSample(busReadTimestamp + sample) >= thresholdLinear;
+            
+            if (busTriggered && busChannelPtr->readEdge(busReadTimestamp + sample))
+                wasBusTriggered = false;
+        }
+        
         // Check audio threshold (update current state)
         isTriggered = currentLevel >= thresholdLinear;
       /*  if(midiTriggered)
@@ -335,11 +858,23 @@ void ThresholdTriggerAudioProcessor::processBlock (juce::AudioBuffer<float>& buf
            isTriggered = currentLevel >= thresholdLinear;*/
         // Process envelope (uses wasTriggered and wasMidiTriggered from previous sample)
         float envelopeOutput = processEnvelope(currentLevel);
+        pushScopeSamples(currentLevel, envelopeOutput, triggerEdgeDetected, 1);
+        
+        if (publishToBus)
+            publishingChannel->writeSample(blockTimestamp + sample, envelopeOutput, triggerEdgeDetected);
         
         // Apply envelope to output
         for (int channel = 0; channel < totalNumInputChannels; ++channel)
         {
             float input = buffer.getSample(channel, sample);
+            
+            // Delay the audio by the source latency so the gate opens on the transient
+            if (activeSourceDelaySamples > 0)
+            {
+                sourceDelay.pushSample(channel, input);
+                input = sourceDelay.popSample(channel);
+            }
+            
             float output = input * envelopeOutput;
             buffer.setSample(channel, sample, output);
         }
@@ -347,7 +882,12 @@ void ThresholdTriggerAudioProcessor::processBlock (juce::AudioBuffer<float>& buf
         // Store current states as "previous" for next sample (AFTER processEnvelope)
         wasTriggered = isTriggered;
         wasMidiTriggered = midiTriggered;
+        wasOnsetTriggered = onsetTriggered;
+        wasBusTriggered = busTriggered;
     }
+    
+    if (publishToBus)
+        publishingChannel->endBlock(blockTimestamp + numSamples);
 }
 
 //==============================================================================
@@ -376,6 +916,8 @@ void ThresholdTriggerAudioProcessor::setStateInformation (const void* data, int
     if (xmlState.get() != nullptr)
         if (xmlState->hasTagName (valueTreeState.state.getType()))
             valueTreeState.replaceState (juce::ValueTree::fromXml (*xmlState));
+
+    setTriggerBusChannel (valueTreeState.state.getProperty ("busChannel", "A").toString());
 }
 
 //==============================================================================
@@ -1,9 +1,14 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "SharedResources.h"
+#include "OnsetDetector.h"
+#include "TriggerBus.h"
 
 //==============================================================================
-class ThresholdTriggerAudioProcessor : public juce::AudioProcessor
+class ThresholdTriggerAudioProcessor : public juce::AudioProcessor,
+                                       private juce::AudioProcessorValueTreeState::Listener,
+                                       private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -51,11 +56,52 @@ public:
     float getCurrentLevel() const { return currentLevel; }
     bool getMidiTriggerState() const { return midiTriggered; }
 
+    //==============================================================================
+    // Decimated history for the scrolling scope. The audio thread summarises
+    // every few milliseconds of input into one column; the editor drains them.
+    // minLevel/maxLevel are the range of the detector level smoothed over
+    // scopeSmoothingSeconds within the column.
+    struct ScopeColumn
+    {
+        float minLevel = 0.0f;
+        float maxLevel = 0.0f;
+        float envelope = 0.0f;
+        bool triggerEdge = false;
+    };
+
+    static constexpr int scopeFifoSize = 1024;
+    static constexpr double scopeSecondsPerColumn = 0.01;
+    static constexpr double scopeSmoothingSeconds = 0.005;
+
+    // Copies up to maxColumns pending columns into dest, oldest first (message thread only)
+    int popScopeColumns (ScopeColumn* dest, int maxColumns);
+
+    //==============================================================================
+    // Trigger bus channel this instance publishes to and/or subscribes from (message thread)
+    void setTriggerBusChannel (const juce::String& name);
+    juce::String getTriggerBusChannel() const;
+    
+    // True while subscribing and the last block couldn't read all the bus samples it needed,
+    // even allowing for the look-behind (e.g. the publisher stalled or stopped processing)
+    bool isBusSubscriberStarved() const { return busSubscriberStarved.load(std::memory_order_relaxed); }
+    
+    // True while subscribing to a channel no instance publishes to
+    bool isBusSubscriberWithoutPublisher() const { return busSubscriberWithoutPublisher.load(std::memory_order_relaxed); }
+    
+    // True while "Publish To Bus" is on but another instance already publishes to the channel
+    bool isBusPublishRefused() const { return busPublishRefused.load(std::memory_order_relaxed); }
+    
+    // True while "Publish To Bus" is on but the trigger source is the bus itself
+    bool isBusPublishBlocked() const { return busPublishBlocked.load(std::memory_order_relaxed); }
+
 private:
     //==============================================================================
     juce::AudioProcessorValueTreeState valueTreeState;
     
     juce::String pluginVersion;
+    
+    // Process-wide tables shared with every other instance
+    juce::SharedResourcePointer<SharedLookupTables> lookupTables;
   //  juce::StreamingSocket logSocket;
     // Parameters
     std::atomic<float>* thresholdParam;
@@ -63,6 +109,9 @@ private:
     std::atomic<float>* decayParam;
     std::atomic<float>* retriggerParam;
     std::atomic<float>* midiModeParam;
+    std::atomic<float>* triggerSourceParam;
+    std::atomic<float>* busPublishParam;
+    std::atomic<float>* controlRateParam;
     
     // Internal state
     float currentLevel = 0.0f;
@@ -77,17 +126,78 @@ private:
     // Envelope state
     enum EnvelopeState { Attack, Decay, Idle };
     EnvelopeState envelopeState = Idle;
+    bool attackLatched = false;  // attack runs to the peak regardless of trigger state
     
     // MIDI trigger state
     bool midiTriggered = false;
     bool wasMidiTriggered = false;
     
+    // Onset trigger state
+    OnsetDetector onsetDetector;
+    bool onsetModeActive = false;
+    std::atomic<int> onsetLatencySamples { 0 };
+    
+    // Delay on the audio path that lines it up with a late trigger source:
+    // the onset detector latency, or the bus look-behind
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> sourceDelay;
+    int activeSourceDelaySamples = 0;
+    bool onsetTriggered = false;
+    bool wasOnsetTriggered = false;
+    
+    // Trigger bus state
+    juce::SharedResourcePointer<TriggerBus> triggerBus;
+    std::atomic<TriggerBus::Channel*> busChannel { nullptr };
+    std::atomic<bool> busSubscriberStarved { false };
+    std::atomic<bool> busSubscriberWithoutPublisher { false };
+    std::atomic<bool> busPublishRefused { false };
+    std::atomic<bool> busPublishBlocked { false };
+    TriggerBus::Channel* publishingChannel = nullptr;  // channel we hold the publisher claim on
+    std::atomic<int> busLookBehindSamples { 0 };
+    juce::int64 busReadCursor = 0;      // subscriber position while the transport is stopped
+    juce::int64 busReadCursorWrittenEnd = 0;
+    bool busReadCursorValid = false;
+    bool busTriggered = false;
+    bool wasBusTriggered = false;
+    
+    // Set by processEnvelope when a new trigger edge starts the attack
+    bool triggerEdgeDetected = false;
+    
+    // Scope history (single producer: audio thread, single consumer: editor)
+    juce::AbstractFifo scopeFifo { scopeFifoSize };
+    std::array<ScopeColumn, scopeFifoSize> scopeColumns;
+    ScopeColumn pendingColumn;
+    int pendingColumnSamples = 0;
+    int scopeSamplesPerColumn = 441;
+    float scopeSmoothingSamples = 220.5f;
+    float scopeMeanSquare = 0.0f;
+    
     // Sample rate
     double sampleRate = 44100.0;
     
+    // Control-rate mode: detector and envelope step once per sub-block of this
+    // many samples, with the gain linearly interpolated in between
+    static constexpr int controlIntervals[] = { 1, 8, 16 };
+    static constexpr int maxControlInterval = 16;
+    
+    // Scope smoothing coefficient for a step of each control interval
+    float scopeSmoothingCoeffs[std::size(controlIntervals)] {};
+    
     // Helper functions
-    void updateCoefficients();
+    int getTriggerMode() const;
+    int getReportedLatencySamples() const;
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+    void updateCoefficients(int samplesPerStep = 1);
     float processEnvelope(float inputLevel);
+    void pushScopeSamples(float level, float envelope, bool triggerEdge, int numSamples);
+    bool getHostTimestamp(juce::int64& timestamp) const;
+    juce::int64 getFreeRunningReadTimestamp(const TriggerBus::Channel& channel, int numSamples);
+    void updatePublisherClaim(TriggerBus::Channel* wantedChannel);
+    void processBlockAtControlRate(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages,
+                                   int numInputChannels, float thresholdLinear, int controlInterval,
+                                   TriggerBus::Channel* publishChannel, juce::int64 blockTimestamp);
+    bool processIdleBlock(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages,
+                          int numInputChannels, float thresholdLinear);
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ThresholdTriggerAudioProcessor)
@@ -0,0 +1,94 @@
+#include "SharedResources.h"
+
+//==============================================================================
+SharedLookupTables::SharedLookupTables()
+    : decibelsToGainTable([](float decibels) { return juce::Decibels::decibelsToGain(decibels); },
+                          minDecibels, maxDecibels,
+                          (size_t) juce::roundToInt((maxDecibels - minDecibels) * 10.0f) + 1),
+      gainToDecibelsTable([](float gain) { return juce::Decibels::gainToDecibels(gain, minDecibels); },
+                          0.0f, 1.0f, 4096)
+{
+}
+
+float SharedLookupTables::decibelsToGain(float decibels) const noexcept
+{
+    if (decibels < minDecibels || decibels > maxDecibels)
+        return juce::Decibels::decibelsToGain(decibels);
+    
+    return decibelsToGainTable.processSampleUnchecked(decibels);
+}
+
+float SharedLookupTables::gainToDecibels(float gain) const noexcept
+{
+    if (gain > 1.0f)
+        return juce::Decibels::gainToDecibels(gain);
+    
+    return gainToDecibelsTable.processSample(gain);
+}
+
+float SharedLookupTables::meterPositionForGain(float gain) const noexcept
+{
+    return juce::jlimit(0.0f, 1.0f, (gainToDecibels(gain) - minDecibels) / (maxDecibels - minDecibels));
+}
+
+//==============================================================================
+void SharedRefreshScheduler::addClient(juce::Component& component, Client& client)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    
+    entries.push_back({ &component, &client });
+    
+    if (hostComponent == nullptr || ! hostComponent->isShowing())
+        chooseHost();
+}
+
+void SharedRefreshScheduler::removeClient(Client& client)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [&client](const Entry& e) { return e.client == &client; }),
+                  entries.end());
+    
+    chooseHost();
+}
+
+void SharedRefreshScheduler::chooseHost()
+{
+    // Prefer a client that's already on screen; otherwise any client, whose
+    // attachment will start firing once it's added to a window
+    juce::Component* newHost = nullptr;
+    
+    for (auto& entry : entries)
+    {
+        if (entry.component == nullptr)
+            continue;
+        
+        if (newHost == nullptr || entry.component->isShowing())
+            newHost = entry.component.getComponent();
+        
+        if (newHost->isShowing())
+            break;
+    }
+    
+    if (newHost == hostComponent.getComponent() && (vBlankAttachment != nullptr) == (newHost != nullptr))
+        return;
+    
+    vBlankAttachment.reset();
+    hostComponent = newHost;
+    
+    if (newHost != nullptr)
+        vBlankAttachment = std::make_unique<juce::VBlankAttachment>(newHost, [this] { dispatch(); });
+}
+
+void SharedRefreshScheduler::dispatch()
+{
+    // Index loop: a client may remove itself from within refresh()
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        auto& entry = entries[i];
+        
+        if (entry.component != nullptr && entry.component->isShowing())
+            entry.client->refresh();
+    }
+}
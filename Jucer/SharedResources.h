@@ -0,0 +1,74 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Process-wide state shared by every plugin instance. Access these through
+// juce::SharedResourcePointer so they are created with the first instance and
+// destroyed with the last one.
+
+//==============================================================================
+// Immutable lookup tables, built once on construction and safe to read from
+// any thread afterwards.
+class SharedLookupTables
+{
+public:
+    SharedLookupTables();
+    
+    // Range covered by the threshold parameter and the meters
+    static constexpr float minDecibels = -60.0f;
+    static constexpr float maxDecibels = 0.0f;
+    
+    // dB -> linear gain, sampled on the threshold parameter's 0.1 dB grid
+    float decibelsToGain(float decibels) const noexcept;
+    
+    // Linear gain -> dB, clamped to minDecibels
+    float gainToDecibels(float gain) const noexcept;
+    
+    // Meter curve: linear gain -> 0..1 position on the minDecibels..maxDecibels scale
+    float meterPositionForGain(float gain) const noexcept;
+    
+private:
+    juce::dsp::LookupTableTransform<float> decibelsToGainTable;
+    juce::dsp::LookupTableTransform<float> gainToDecibelsTable;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedLookupTables)
+};
+
+//==============================================================================
+// One display refresh shared by all open editors. It is driven by the vertical
+// blank of a showing client's window, and only clients that are currently
+// showing get a refresh() call, so the message thread cost follows the number
+// of visible meters rather than the number of plugin instances.
+class SharedRefreshScheduler
+{
+public:
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+        virtual void refresh() = 0;
+    };
+    
+    SharedRefreshScheduler() = default;
+    
+    // Message thread only
+    void addClient(juce::Component& component, Client& client);
+    void removeClient(Client& client);
+    
+private:
+    struct Entry
+    {
+        juce::Component::SafePointer<juce::Component> component;
+        Client* client = nullptr;
+    };
+    
+    void dispatch();
+    void chooseHost();
+    
+    std::vector<Entry> entries;
+    juce::Component::SafePointer<juce::Component> hostComponent;
+    std::unique_ptr<juce::VBlankAttachment> vBlankAttachment;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedRefreshScheduler)
+};
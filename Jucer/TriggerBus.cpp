@@ -0,0 +1,74 @@
+#include "TriggerBus.h"
+
+//==============================================================================
+TriggerBus::Channel::Channel()
+    : ring(new std::atomic<float>[ringSize]),
+      edgeRing(new std::atomic<bool>[ringSize])
+{
+    for (int i = 0; i < ringSize; ++i)
+    {
+        ring[(size_t) i].store(0.0f, std::memory_order_relaxed);
+        edgeRing[(size_t) i].store(false, std::memory_order_relaxed);
+    }
+}
+
+bool TriggerBus::Channel::claimPublisher(const void* owner) noexcept
+{
+    const void* expected = nullptr;
+    return publisher.compare_exchange_strong(expected, owner, std::memory_order_acq_rel)
+        || expected == owner;
+}
+
+void TriggerBus::Channel::releasePublisher(const void* owner) noexcept
+{
+    const void* expected = owner;
+    publisher.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+}
+
+void TriggerBus::Channel::beginBlock(juce::int64 timestamp)
+{
+    // A jump in the timeline (relocate, loop, transport start) invalidates
+    // everything published so far
+    if (timestamp != expectedTimestamp)
+    {
+        validFrom.store(timestamp, std::memory_order_release);
+        writtenEnd.store(timestamp, std::memory_order_release);
+    }
+}
+
+void TriggerBus::Channel::writeSilence(juce::int64 timestamp, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+        writeSample(timestamp + i, 0.0f, false);
+}
+
+void TriggerBus::Channel::endBlock(juce::int64 endTimestamp) noexcept
+{
+    expectedTimestamp = endTimestamp;
+    writtenEnd.store(endTimestamp, std::memory_order_release);
+}
+
+int TriggerBus::Channel::getNumAvailable(juce::int64 timestamp, int numSamples) const noexcept
+{
+    auto end = writtenEnd.load(std::memory_order_acquire);
+    auto start = juce::jmax(validFrom.load(std::memory_order_acquire),
+                            end - (juce::int64) (ringSize - safetyMargin));
+    
+    if (timestamp < start || timestamp >= end)
+        return 0;
+    
+    return (int) juce::jmin((juce::int64) numSamples, end - timestamp);
+}
+
+//==============================================================================
+TriggerBus::Channel* TriggerBus::getChannel(const juce::String& name)
+{
+    const juce::ScopedLock sl(lock);
+    
+    auto& channel = channels[name];
+    
+    if (channel == nullptr)
+        channel = std::make_unique<Channel>();
+    
+    return channel.get();
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// In-process trigger bus shared by every plugin instance through
+// juce::SharedResourcePointer. A publishing instance writes its per-sample
+// envelope, and the samples where it was (re)triggered, into a named channel;
+// subscribing instances read it straight out
+// of the channel's ring, indexed by block timestamp, so no audio is copied.
+// Subscribers read a fixed look-behind in the past (and delay their own audio
+// by the same amount), so it doesn't matter which instance runs first.
+// Blocks are stamped with the host timeline while the transport plays; while
+// it's stopped the publisher continues its own clock and subscribers follow it.
+class TriggerBus
+{
+public:
+    //==============================================================================
+    // Single-publisher ring of envelope values keyed by absolute sample time.
+    // Lock-free: the publisher stores samples then releases the end timestamp,
+    // subscribers acquire the end timestamp and read only what's before it.
+    class Channel
+    {
+    public:
+        Channel();
+        
+        static constexpr int ringSize = 1 << 16;
+        
+        // Only one instance may publish at a time. Returns true if owner now
+        // holds the channel (or already did); false if another instance does.
+        bool claimPublisher(const void* owner) noexcept;
+        void releasePublisher(const void* owner) noexcept;
+        bool hasPublisher() const noexcept { return publisher.load(std::memory_order_acquire) != nullptr; }
+        
+        // Publisher side (audio thread of the instance holding the claim)
+        void beginBlock(juce::int64 timestamp);
+        void writeSample(juce::int64 timestamp, float value, bool triggerEdge) noexcept
+        {
+            ring[(size_t) (timestamp & ringMask)].store(value, std::memory_order_relaxed);
+            edgeRing[(size_t) (timestamp & ringMask)].store(triggerEdge, std::memory_order_relaxed);
+        }
+        void writeSilence(juce::int64 timestamp, int numSamples) noexcept;
+        void endBlock(juce::int64 endTimestamp) noexcept;
+        
+        // The publisher's own free-running clock: where its next block starts if
+        // it continues contiguously. Used while the host transport is stopped.
+        juce::int64 getNextPublishTimestamp() const noexcept { return expectedTimestamp; }
+        
+        // Subscriber side: returns how many samples from timestamp onwards can
+        // be read. Subscribers read a look-behind of at least one maximum block
+        // in the past, so normally everything they ask for has been published.
+        int getNumAvailable(juce::int64 timestamp, int numSamples) const noexcept;
+        
+        // Where the publisher has written up to; subscribers follow this while
+        // the host transport is stopped
+        juce::int64 getWrittenEnd() const noexcept
+        {
+            return writtenEnd.load(std::memory_order_acquire);
+        }
+        float readSample(juce::int64 timestamp) const noexcept
+        {
+            return ring[(size_t) (timestamp & ringMask)].load(std::memory_order_relaxed);
+        }
+        
+        // True where the publisher's envelope started a new attack. A retrigger
+        // can happen while the envelope is still high, so subscribers can't see
+        // it from the envelope values alone.
+        bool readEdge(juce::int64 timestamp) const noexcept
+        {
+            return edgeRing[(size_t) (timestamp & ringMask)].load(std::memory_order_relaxed);
+        }
+        
+    private:
+        static constexpr juce::int64 ringMask = ringSize - 1;
+        
+        // Keep readers well clear of the region the publisher is overwriting
+        static constexpr int safetyMargin = 8192;
+        
+        std::unique_ptr<std::atomic<float>[]> ring;
+        std::unique_ptr<std::atomic<bool>[]> edgeRing;
+        std::atomic<const void*> publisher { nullptr };
+        std::atomic<juce::int64> validFrom { 0 };
+        std::atomic<juce::int64> writtenEnd { 0 };
+        juce::int64 expectedTimestamp = 0;
+        
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Channel)
+    };
+    
+    TriggerBus() = default;
+    
+    // Returns the channel with this name, creating it if needed. Channels live
+    // as long as the bus, so the pointer can be handed to the audio thread.
+    // Not real-time safe: call from the message thread.
+    Channel* getChannel(const juce::String& name);
+    
+private:
+    juce::CriticalSection lock;
+    std::map<juce::String, std::unique_ptr<Channel>> channels;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TriggerBus)
+};